@@ -0,0 +1,151 @@
+/**
+ * Times every coding kernel against the generic bit by bit path on the same input.
+ * Usage: archiver_bench [input_file]; besides the file two synthetic inputs are measured: one with codes
+ * not longer than 8 bits and one with codes longer than 16 bits, which decode through escapes.
+ * Encoding kernels whose limit is less than the longest code are skipped.
+ */
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "Huffman.hpp"
+#include "HuffmanKernels.hpp"
+
+using namespace huffman;
+
+const int repeats = 5;
+
+std::string syntheticInput(std::initializer_list<double> weights) {
+    std::mt19937 generator(2021);
+    std::discrete_distribution<int> distribution(weights);
+    std::string input(16 << 20, 0);
+    for (char& c : input) {
+        c = static_cast<char>(distribution(generator));
+    }
+    return input;
+}
+
+std::string readInput(const std::string& fileName) {
+    std::ifstream in(fileName);
+    if (!in.is_open())
+        throw HuffmanLoadFileException(fileName);
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+/** Runs coder several times, prints the best speed and returns its output */
+std::string measure(const std::string& name, std::size_t inputSize, const std::function<std::string()>& coder) {
+    std::string output;
+    double bestSeconds = 0;
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        const auto start = std::chrono::steady_clock::now();
+        output = coder();
+        const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+        if (repeat == 0 || seconds.count() < bestSeconds)
+            bestSeconds = seconds.count();
+    }
+    std::cout << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+              << inputSize / bestSeconds / (1 << 20) << " MiB/s" << std::endl;
+    return output;
+}
+
+void skip(const std::string& name) {
+    std::cout << std::left << std::setw(28) << name << "skipped, codes are too long" << std::endl;
+}
+
+void run(const std::string& inputName, const std::string& input) {
+    const std::vector<bool> noPairs;
+    std::vector<std::size_t> rawStatistic(byteAlphabetSize, 0);
+    for (char c : input) {
+        rawStatistic[static_cast<uint8_t>(c)]++;
+    }
+    std::vector<WordStatistic> statistic;
+    for (std::size_t id = 0; id < byteAlphabetSize; id++) {
+        if (rawStatistic[id] != 0)
+            statistic.emplace_back(id, rawStatistic[id]);
+    }
+    if (statistic.empty()) {
+        std::cout << inputName << " is empty" << std::endl;
+        return;
+    }
+    const Tree tree(statistic);
+    const Table table = tree.getTable(byteAlphabetSize);
+    const auto codeLength = maxCodeLength(table);
+    const auto codes = packCodes(table);
+    std::cout << std::endl << inputName << ": " << input.size() << " bytes, longest code: " << codeLength << " bits" << std::endl;
+
+    std::cout << "Encode" << std::endl;
+    const auto compressed = measure("writeWords (generic)", input.size(), [&]() {
+        std::istringstream in(input);
+        WordReader reader(in, noPairs);
+        std::ostringstream out;
+        writeWords(reader, OutputBitStream(out, "bench"), table);
+        return out.str();
+    });
+    auto encodeKernel = [&](const std::string& name, std::size_t maxLength, auto encode) {
+        if (codeLength > maxLength)
+            return skip(name);
+        const auto output = measure(name, input.size(), [&]() {
+            std::istringstream in(input);
+            WordReader reader(in, noPairs);
+            std::ostringstream out;
+            encode(reader, out);
+            return out.str();
+        });
+        if (output != compressed)
+            throw HuffmanException(name + " output differs from generic one");
+    };
+    encodeKernel("encodeWords<uint64_t, 32>", 32, [&](WordReader& reader, std::ostream& out) {
+        encodeWords<uint64_t, 32>(reader, out, "bench", codes);
+    });
+    encodeKernel("encodeWords<uint64_t, 56>", 56, [&](WordReader& reader, std::ostream& out) {
+        encodeWords<uint64_t, 56>(reader, out, "bench", codes);
+    });
+
+    std::size_t size = 0;
+    for (auto wordStat : statistic) {
+        size += wordStat.stat * table.at(wordStat.word).size();
+    }
+    std::cout << "Decode" << std::endl;
+    measure("readWords (generic)", input.size(), [&]() {
+        std::istringstream in(compressed);
+        std::ostringstream out;
+        readWords(InputBitStream(in, "bench"), out, size, tree);
+        if (out.str() != input)
+            throw HuffmanException("readWords output differs from input");
+        return out.str();
+    });
+    auto decodeKernel = [&](const std::string& name, int lookupBits, auto decode) {
+        const auto lookup = buildLookup(tree, lookupBits);
+        measure(name, input.size(), [&]() {
+            std::istringstream in(compressed);
+            std::ostringstream out;
+            decode(in, out, lookup);
+            if (out.str() != input)
+                throw HuffmanException(name + " output differs from input");
+            return out.str();
+        });
+    };
+    decodeKernel("decodeWords<8, uint64_t>", 8, [&](std::istream& in, std::ostream& out, const Lookup& lookup) {
+        decodeWords<8, uint64_t>(in, "bench", out, "bench", size, lookup);
+    });
+    decodeKernel("decodeWords<11, uint64_t>", 11, [&](std::istream& in, std::ostream& out, const Lookup& lookup) {
+        decodeWords<11, uint64_t>(in, "bench", out, "bench", size, lookup);
+    });
+    decodeKernel("decodeWords<16, uint64_t>", 16, [&](std::istream& in, std::ostream& out, const Lookup& lookup) {
+        decodeWords<16, uint64_t>(in, "bench", out, "bench", size, lookup);
+    });
+}
+
+int main(int argc, char* argv[]) {
+    run("Short codes", syntheticInput({40, 20, 12, 8, 6, 4, 3, 2, 1, 1, 1, 1}));
+    std::initializer_list<double> skewed = {1 << 20, 1 << 19, 1 << 18, 1 << 17, 1 << 16, 1 << 15, 1 << 14, 1 << 13, 1 << 12, 1 << 11,
+                                            1 << 10, 1 << 9, 1 << 8, 1 << 7, 1 << 6, 1 << 5, 1 << 4, 1 << 3, 1 << 2, 2, 1, 1};
+    run("Long codes", syntheticInput(skewed));
+    if (argc > 1)
+        run(argv[1], readInput(argv[1]));
+    return 0;
+}
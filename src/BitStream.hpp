@@ -18,20 +18,20 @@ const int byteBits = std::numeric_limits<uint8_t>::digits;
 /** Stream to read from compressed file */
 class InputBitStream {
 public:
-    explicit InputBitStream(std::ifstream &in_, std::string fileName_) : in(in_), fileName(fileName_) {}
+    explicit InputBitStream(std::istream &in_, std::string fileName_) : in(in_), fileName(fileName_) {}
     bool readBit();
 
 private:
     uint8_t curByte = 0;
     int cntRead = byteBits;
-    std::ifstream &in;
+    std::istream &in;
     const std::string fileName;
 };
 
 /** Stream to write to compressed file */
 class OutputBitStream {
 public:
-    explicit OutputBitStream(std::ofstream &out_, std::string fileName_) : out(out_), fileName(fileName_) {}
+    explicit OutputBitStream(std::ostream &out_, std::string fileName_) : out(out_), fileName(fileName_) {}
 
     void writeBit(bool bit);
     void write(const std::vector<bool> &v);
@@ -40,7 +40,7 @@ public:
 private:
     uint8_t curByte = 0;
     int cntWriten = 0;
-    std::ofstream &out;
+    std::ostream &out;
     const std::string fileName;
 };
 
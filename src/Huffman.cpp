@@ -4,9 +4,13 @@
 
 #include <memory>
 #include <set>
+#include <filesystem>
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <utility>
 #include "Huffman.hpp"
+#include "HuffmanKernels.hpp"
 
 namespace huffman {
 
@@ -20,80 +24,187 @@ void checkOutputFileExistence(std::ofstream& out, std::string outputFile) {
         throw HuffmanLoadFileException(outputFile);
 }
 
-void writeCompressedFile(std::string inputFile, OutputBitStream outStream, const Table& table) {
-    std::ifstream in(inputFile);
-    checkInputFileExistence(in, inputFile);
-    uint8_t byte;
-    while (in.read(reinterpret_cast<char *>(&byte), sizeof byte)) {
-        outStream.write(table.at(byte));
-    }
-    outStream.close();
+const std::size_t pairAlphabetFlag = std::size_t(1) << (std::numeric_limits<std::size_t>::digits - 1);
+const std::size_t repeatTableFlag = std::size_t(1) << (std::numeric_limits<std::size_t>::digits - 2);
+const std::size_t indexMagic = 0x5844'4e49'4655'4801; // ends archive with segment index
+const std::size_t maxPairWords = 1024;
+const std::size_t minPairFrequency = 32;
+
+/** Part of input file which is coded as one segment */
+struct InputPart {
+    std::string file;
+    std::size_t begin;
+    std::size_t size;
+};
+
+std::ifstream openPart(const InputPart& input) {
+    std::ifstream in(input.file);
+    checkInputFileExistence(in, input.file);
+    in.seekg(input.begin);
+    return in;
 }
 
-void writeUncompressedFile(InputBitStream inStream, std::string outputFile, std::size_t fileSize, const std::unique_ptr<Tree>& tree) {
-    std::ofstream out(outputFile);
-    checkOutputFileExistence(out, outputFile);
-    const Node* curNode = tree->getRoot();
-    for (std::size_t pos = 0; pos < fileSize; pos++) {
-        curNode = tree->go(curNode, inStream.readBit());
-        if (curNode->terminalFlag) {
-            uint8_t word = curNode->word;
-            curNode = tree->getRoot();
-            out.write(reinterpret_cast<char *>(&word), sizeof word);
-        }
+void writeCompressedFile(const InputPart& input, std::ostream& out, std::string outputFile, const Table& table, const std::vector<bool>& pairs) {
+    auto in = openPart(input);
+    WordReader reader(in, pairs, input.size);
+    const auto codeLength = maxCodeLength(table);
+    if (codeLength <= 32) {
+        encodeWords<uint64_t, 32>(reader, out, outputFile, packCodes(table));
+    } else if (codeLength <= 56) {
+        encodeWords<uint64_t, 56>(reader, out, outputFile, packCodes(table));
+    } else {
+        writeWords(reader, OutputBitStream(out, outputFile), table);
     }
-    if (curNode != tree->getRoot()) {
-        throw HuffmanLogicError();
+}
+
+/** Tree and lookup of one statistic, segments that repeat the table decode with them as well */
+struct Decoding {
+    std::unique_ptr<Tree> tree;
+    Lookup lookup;
+    int lookupBits = 0;
+};
+
+Decoding buildDecoding(const Header& header) {
+    Decoding decoding;
+    decoding.tree = std::make_unique<Tree>(header.statistic);
+    const auto codeLength = maxCodeLength(decoding.tree->getTable(alphabetSize(header.alphabet)));
+    decoding.lookupBits = (codeLength <= 8 ? 8 : 11); // longer codes are rare, they go through escapes
+    decoding.lookup = buildLookup(*decoding.tree, decoding.lookupBits);
+    return decoding;
+}
+
+void writeUncompressedFile(std::istream& in, std::string inputFile, std::ostream& out, std::string outputFile,
+                           std::size_t size, const Decoding& decoding) {
+    if (decoding.lookupBits == 8) {
+        decodeWords<8, uint64_t>(in, inputFile, out, outputFile, size, decoding.lookup);
+    } else {
+        decodeWords<11, uint64_t>(in, inputFile, out, outputFile, size, decoding.lookup);
     }
 }
 
-Header readHeader(std::ifstream& in, std::string inputFile) {
+Header readHeader(std::istream& in, std::string inputFile) {
     Header header;
     std::size_t statisticSize;
     in.read(reinterpret_cast<char *>(&header.size), sizeof header.size);
     in.read(reinterpret_cast<char *>(&statisticSize), sizeof statisticSize);
     if (in.fail())
         throw HuffmanInvalidCompressedFile(inputFile);
+    if (statisticSize & pairAlphabetFlag) {
+        header.alphabet = Alphabet::BYTE_PAIR;
+        statisticSize ^= pairAlphabetFlag;
+    }
+    if (statisticSize & repeatTableFlag) {
+        header.repeatTable = true;
+        if (statisticSize != repeatTableFlag)
+            throw HuffmanInvalidCompressedFile(inputFile);
+        return header;
+    }
+    if (statisticSize == 0 || statisticSize > alphabetSize(header.alphabet))
+        throw HuffmanInvalidCompressedFile(inputFile);
     for (std::size_t pos = 0; pos < statisticSize; pos++) {
-        uint8_t word;
+        Word word = 0;
         std::size_t stat;
-        in.read(reinterpret_cast<char *>(&word), sizeof word);
+        if (header.alphabet == Alphabet::BYTE) {
+            uint8_t byte;
+            in.read(reinterpret_cast<char *>(&byte), sizeof byte);
+            word = byte;
+        } else {
+            in.read(reinterpret_cast<char *>(&word), sizeof word);
+        }
         in.read(reinterpret_cast<char *>(&stat), sizeof stat);
-        if (in.fail())
+        if (in.fail() || word >= alphabetSize(header.alphabet))
             throw HuffmanInvalidCompressedFile(inputFile);
         header.statistic.emplace_back(word, stat);
     }
     return header;
 }
 
-void writeHeader(std::ofstream& out, std::string outputFile, const std::vector<WordStatistic>& statistic, const Table& table) {
-    std::size_t fileSize = 0;
-    std::size_t statisticSize = statistic.size();
+/** Size of coded words in bits */
+std::size_t codedSize(const std::vector<WordStatistic>& statistic, const Table& table) {
+    std::size_t size = 0;
     for (auto wordStat : statistic) {
-        fileSize += wordStat.stat * table.at(wordStat.word).size();
+        size += wordStat.stat * table.at(wordStat.word).size();
     }
+    return size;
+}
+
+/** Size of header and coded words in bytes */
+std::size_t archiveSize(Alphabet alphabet, const std::vector<WordStatistic>& statistic, const Table& table) {
+    const std::size_t wordSize = (alphabet == Alphabet::BYTE ? sizeof(uint8_t) : sizeof(Word));
+    return 2 * sizeof(std::size_t) + statistic.size() * (wordSize + sizeof(std::size_t))
+           + (codedSize(statistic, table) + byteBits - 1) / byteBits;
+}
+
+void writeRepeatHeader(std::ostream& out, std::string outputFile, std::size_t size) {
+    std::size_t statisticSize = repeatTableFlag;
+    out.write(reinterpret_cast<char *>(&size), sizeof size);
+    out.write(reinterpret_cast<char *>(&statisticSize), sizeof statisticSize);
+    if (out.fail())
+        throw HuffmanWriteFileException(outputFile);
+}
+
+void writeHeader(std::ostream& out, std::string outputFile, Alphabet alphabet, const std::vector<WordStatistic>& statistic, const Table& table) {
+    std::size_t fileSize = codedSize(statistic, table);
+    std::size_t statisticSize = statistic.size();
+    if (alphabet == Alphabet::BYTE_PAIR)
+        statisticSize |= pairAlphabetFlag;
     out.write(reinterpret_cast<char *>(&fileSize), sizeof fileSize);
     out.write(reinterpret_cast<char *>(&statisticSize), sizeof statisticSize);
     if (out.fail())
         throw HuffmanWriteFileException(outputFile);
     for (auto wordStat : statistic) {
-        out.write(reinterpret_cast<char *>(&wordStat.word), sizeof wordStat.word);
+        if (alphabet == Alphabet::BYTE) {
+            uint8_t byte = wordStat.word;
+            out.write(reinterpret_cast<char *>(&byte), sizeof byte);
+        } else {
+            out.write(reinterpret_cast<char *>(&wordStat.word), sizeof wordStat.word);
+        }
         out.write(reinterpret_cast<char *>(&wordStat.stat), sizeof wordStat.stat);
         if (out.fail())
             throw HuffmanWriteFileException(outputFile);
     }
 }
 
-std::vector<WordStatistic> getStatistic(std::string inputFile) {
-    std::ifstream in(inputFile);
-    checkInputFileExistence(in, inputFile);
-    std::size_t rawStatistic[maxByte + 1] = {0};
-    uint8_t byte;
-    while (in.read(reinterpret_cast<char *>(&byte), sizeof byte)) {
-        rawStatistic[byte]++;
+/** Marks the most frequent byte pairs of the file, rare pairs stay escaped as two single bytes */
+std::vector<bool> selectPairs(const InputPart& input, Alphabet alphabet) {
+    if (alphabet == Alphabet::BYTE)
+        return {};
+    auto in = openPart(input);
+    std::vector<std::size_t> pairStatistic(byteAlphabetSize * byteAlphabetSize, 0);
+    const std::vector<bool> bytes;
+    WordReader reader(in, bytes, input.size);
+    Word prevWord, word;
+    if (reader.read(prevWord)) {
+        while (reader.read(word)) {
+            pairStatistic[(prevWord << byteBits) | word]++;
+            prevWord = word;
+        }
+    }
+    std::vector<std::pair<std::size_t, std::size_t>> frequentPairs;
+    for (std::size_t id = 0; id < pairStatistic.size(); id++) {
+        if (pairStatistic[id] >= minPairFrequency)
+            frequentPairs.emplace_back(pairStatistic[id], id);
+    }
+    std::sort(frequentPairs.begin(), frequentPairs.end(), std::greater<>());
+    if (frequentPairs.size() > maxPairWords)
+        frequentPairs.resize(maxPairWords);
+    std::vector<bool> pairs(byteAlphabetSize * byteAlphabetSize, false);
+    for (auto pair : frequentPairs) {
+        pairs[pair.second] = true;
+    }
+    return pairs;
+}
+
+std::vector<WordStatistic> getStatistic(const InputPart& input, const std::vector<bool>& pairs, std::size_t alphabetSize) {
+    auto in = openPart(input);
+    std::vector<std::size_t> rawStatistic(alphabetSize, 0);
+    WordReader reader(in, pairs, input.size);
+    Word word;
+    while (reader.read(word)) {
+        rawStatistic[word]++;
     }
     std::vector<WordStatistic> statistic;
-    for (int id = 0; id <= maxByte; id++) {
+    for (std::size_t id = 0; id < alphabetSize; id++) {
         if (rawStatistic[id] == 0)
             continue;
         statistic.emplace_back(id, rawStatistic[id]);
@@ -110,70 +221,336 @@ std::size_t fileSize(std::string fileName) {
     return end - begin;
 }
 
-SizeStatistic code(std::string inputFile, std::string outputFile) {
-    if (fileSize(inputFile) == 0) {
-        std::ofstream out(outputFile);
-        return SizeStatistic{0, 0, 0};
+/** Everything needed to code one file or segment */
+struct Encoding {
+    Alphabet alphabet;
+    std::vector<bool> pairs;
+    std::vector<WordStatistic> statistic;
+    Table table;
+};
+
+Encoding buildEncoding(const InputPart& input, Alphabet alphabet) {
+    auto pairs = selectPairs(input, alphabet);
+    auto statistic = getStatistic(input, pairs, alphabetSize(alphabet));
+    auto table = Tree(statistic).getTable(alphabetSize(alphabet));
+    if (alphabet == Alphabet::BYTE_PAIR) {
+        auto byteStatistic = getStatistic(input, {}, byteAlphabetSize);
+        auto byteTable = Tree(byteStatistic).getTable(byteAlphabetSize);
+        if (archiveSize(Alphabet::BYTE, byteStatistic, byteTable) <= archiveSize(alphabet, statistic, table))
+            return Encoding{Alphabet::BYTE, {}, std::move(byteStatistic), std::move(byteTable)};
     }
-    auto statistic = getStatistic(inputFile);
-    auto table = Tree(statistic).getTable();
-    std::ofstream out(outputFile);
-    checkOutputFileExistence(out, outputFile);
+    return Encoding{alphabet, std::move(pairs), std::move(statistic), std::move(table)};
+}
+
+/** Encoding of the segment with such header, its pairs are only those which have codes */
+Encoding headerEncoding(const Header& header) {
+    std::vector<bool> pairs;
+    if (header.alphabet == Alphabet::BYTE_PAIR) {
+        pairs.assign(byteAlphabetSize * byteAlphabetSize, false);
+        for (auto wordStat : header.statistic) {
+            if (isPairWord(wordStat.word))
+                pairs[wordStat.word - byteAlphabetSize] = true;
+        }
+    }
+    return Encoding{header.alphabet, std::move(pairs), header.statistic, Tree(header.statistic).getTable(alphabetSize(header.alphabet))};
+}
+
+/**
+ * Chooses between a fresh table and the table of previous segment: the previous one is repeated
+ * if it has codes for all words of input and repeat header with the coded input isn't larger.
+ */
+Encoding chooseEncoding(const InputPart& input, Alphabet alphabet, const Encoding* previous, bool& repeatTable) {
+    repeatTable = false;
+    auto encoding = buildEncoding(input, alphabet);
+    if (previous == nullptr)
+        return encoding;
+    std::vector<WordStatistic> statistic;
+    if (previous->alphabet == Alphabet::BYTE && encoding.alphabet == Alphabet::BYTE) {
+        statistic = encoding.statistic;
+    } else {
+        statistic = getStatistic(input, previous->pairs, alphabetSize(previous->alphabet));
+    }
+    for (auto wordStat : statistic) {
+        if (previous->table.code(wordStat.word).empty())
+            return encoding;
+    }
+    const std::size_t repeatSize = 2 * sizeof(std::size_t) + (codedSize(statistic, previous->table) + byteBits - 1) / byteBits;
+    if (repeatSize > archiveSize(encoding.alphabet, encoding.statistic, encoding.table))
+        return encoding;
+    repeatTable = true;
+    return Encoding{previous->alphabet, previous->pairs, std::move(statistic), previous->table};
+}
+
+SizeStatistic writeSegment(std::ostream& out, std::string outputFile, const InputPart& input, const Encoding& encoding, bool repeatTable) {
     const auto headerBegin = out.tellp();
-    writeHeader(out, outputFile, statistic, table);
+    if (repeatTable) {
+        writeRepeatHeader(out, outputFile, codedSize(encoding.statistic, encoding.table));
+    } else {
+        writeHeader(out, outputFile, encoding.alphabet, encoding.statistic, encoding.table);
+    }
     const auto compressedPartBegin = out.tellp();
-    writeCompressedFile(inputFile, OutputBitStream(out, outputFile), table);
+    writeCompressedFile(input, out, outputFile, encoding.table, encoding.pairs);
     const auto endFile = out.tellp();
-    return SizeStatistic{fileSize(inputFile),
+    return SizeStatistic{input.size,
                          static_cast<std::size_t>(endFile - compressedPartBegin),
-                         static_cast<std::size_t>(compressedPartBegin - headerBegin)};
+                         static_cast<std::size_t>(compressedPartBegin - headerBegin),
+                         1, repeatTable};
+}
+
+/**
+ * Reads offsets of segments from the index at the end of archive.
+ * Archive without index is a single segment, then index begins at the end of file.
+ */
+std::vector<std::size_t> readIndex(std::istream& in, std::string inputFile, std::size_t archiveFileSize, std::size_t& indexBegin) {
+    indexBegin = archiveFileSize;
+    std::size_t segmentsCount = 0, magic = 0;
+    if (archiveFileSize < sizeof segmentsCount + sizeof magic)
+        return {0};
+    in.seekg(archiveFileSize - sizeof segmentsCount - sizeof magic);
+    in.read(reinterpret_cast<char *>(&segmentsCount), sizeof segmentsCount);
+    in.read(reinterpret_cast<char *>(&magic), sizeof magic);
+    if (in.fail())
+        throw HuffmanInvalidCompressedFile(inputFile);
+    if (magic != indexMagic)
+        return {0};
+    const std::size_t maxSegmentsCount = (archiveFileSize - sizeof segmentsCount - sizeof magic) / sizeof(std::size_t);
+    if (segmentsCount == 0 || segmentsCount > maxSegmentsCount)
+        throw HuffmanInvalidCompressedFile(inputFile);
+    indexBegin = archiveFileSize - sizeof segmentsCount - sizeof magic - segmentsCount * sizeof(std::size_t);
+    std::vector<std::size_t> offsets(segmentsCount);
+    in.seekg(indexBegin);
+    in.read(reinterpret_cast<char *>(offsets.data()), segmentsCount * sizeof(std::size_t));
+    if (in.fail() || offsets[0] != 0)
+        throw HuffmanInvalidCompressedFile(inputFile);
+    for (std::size_t pos = 1; pos < segmentsCount; pos++) {
+        if (offsets[pos] <= offsets[pos - 1] || offsets[pos] >= indexBegin)
+            throw HuffmanInvalidCompressedFile(inputFile);
+    }
+    return offsets;
+}
+
+void writeIndex(std::ostream& out, std::string outputFile, std::vector<std::size_t> offsets) {
+    std::size_t segmentsCount = offsets.size();
+    std::size_t magic = indexMagic;
+    out.write(reinterpret_cast<char *>(offsets.data()), segmentsCount * sizeof(std::size_t));
+    out.write(reinterpret_cast<char *>(&segmentsCount), sizeof segmentsCount);
+    out.write(reinterpret_cast<char *>(&magic), sizeof magic);
+    if (out.fail())
+        throw HuffmanWriteFileException(outputFile);
+}
+
+/** Header of the last segment that has its own statistic */
+Header readLastTable(std::istream& in, std::string inputFile, const std::vector<std::size_t>& offsets) {
+    for (auto offset = offsets.rbegin(); offset != offsets.rend(); offset++) {
+        in.seekg(*offset);
+        auto header = readHeader(in, inputFile);
+        if (!header.repeatTable)
+            return header;
+    }
+    throw HuffmanInvalidCompressedFile(inputFile);
+}
+
+SizeStatistic code(std::string inputFile, std::string outputFile, Alphabet alphabet, std::size_t blockSize) {
+    const auto inputFileSize = fileSize(inputFile);
+    if (inputFileSize == 0) {
+        std::ofstream out(outputFile);
+        return SizeStatistic{0, 0, 0, 0, 0};
+    }
+    if (blockSize == 0) {
+        const InputPart input{inputFile, 0, inputFileSize};
+        auto encoding = buildEncoding(input, alphabet);
+        std::ofstream out(outputFile);
+        checkOutputFileExistence(out, outputFile);
+        return writeSegment(out, outputFile, input, encoding, false);
+    }
+    std::ofstream out(outputFile);
+    checkOutputFileExistence(out, outputFile);
+    SizeStatistic statistic{0, 0, 0, 0, 0};
+    std::vector<std::size_t> offsets;
+    std::unique_ptr<Encoding> previous;
+    for (std::size_t begin = 0; begin < inputFileSize; begin += blockSize) {
+        const InputPart input{inputFile, begin, std::min(blockSize, inputFileSize - begin)};
+        bool repeatTable;
+        auto encoding = chooseEncoding(input, alphabet, previous.get(), repeatTable);
+        offsets.push_back(out.tellp());
+        auto segmentStatistic = writeSegment(out, outputFile, input, encoding, repeatTable);
+        statistic.originalSize += segmentStatistic.originalSize;
+        statistic.compressedSize += segmentStatistic.compressedSize;
+        statistic.headerSize += segmentStatistic.headerSize;
+        statistic.segments++;
+        statistic.tablesReused += segmentStatistic.tablesReused;
+        if (!repeatTable)
+            previous = std::make_unique<Encoding>(std::move(encoding));
+    }
+    const auto indexBegin = out.tellp();
+    writeIndex(out, outputFile, offsets);
+    statistic.headerSize += static_cast<std::size_t>(out.tellp() - indexBegin);
+    return statistic;
 }
 
 SizeStatistic decode(std::string inputFile, std::string outputFile) {
-    if (fileSize(inputFile) == 0) {
+    const auto archiveFileSize = fileSize(inputFile);
+    if (archiveFileSize == 0) {
         std::ofstream out(outputFile);
-        return SizeStatistic{0, 0, 0};
+        return SizeStatistic{0, 0, 0, 0, 0};
     }
     std::ifstream in(inputFile);
     checkInputFileExistence(in, inputFile);
-    const auto headerBegin = in.tellg();
-    auto header = readHeader(in, inputFile);
-    auto tree = std::make_unique<Tree> (header.statistic);
-    const auto compressedPartBegin = in.tellg();
+    std::size_t indexBegin;
+    const auto offsets = readIndex(in, inputFile, archiveFileSize, indexBegin);
+    std::ofstream out(outputFile);
+    checkOutputFileExistence(out, outputFile);
+    SizeStatistic statistic{0, 0, archiveFileSize - indexBegin, offsets.size(), 0};
+    Decoding decoding;
+    for (std::size_t pos = 0; pos < offsets.size(); pos++) {
+        in.seekg(offsets[pos]);
+        const auto headerBegin = in.tellg();
+        auto header = readHeader(in, inputFile);
+        if (header.repeatTable) {
+            if (pos == 0)
+                throw HuffmanInvalidCompressedFile(inputFile);
+            statistic.tablesReused++;
+        } else {
+            decoding = buildDecoding(header);
+        }
+        const auto compressedPartBegin = in.tellg();
+        try {
+            writeUncompressedFile(in, inputFile, out, outputFile, header.size, decoding);
+        } catch (const HuffmanLogicError& e) {
+            throw HuffmanInvalidCompressedFile(inputFile);
+        }
+        const auto endSegment = in.tellg();
+        statistic.compressedSize += static_cast<std::size_t>(endSegment - compressedPartBegin);
+        statistic.headerSize += static_cast<std::size_t>(compressedPartBegin - headerBegin);
+    }
+    out.close();
+    statistic.originalSize = fileSize(outputFile);
+    return statistic;
+}
+
+/**
+ * New segment and index are written after the old index, which stays in the file unused:
+ * nothing written before is changed, so on failure archive is truncated back to its old size.
+ */
+SizeStatistic append(std::string inputFile, std::string archiveFile, Alphabet alphabet) {
+    const std::size_t archiveFileSize = std::ifstream(archiveFile).is_open() ? fileSize(archiveFile) : 0;
+    const InputPart input{inputFile, 0, fileSize(inputFile)};
+    if (input.size == 0) {
+        std::ofstream(archiveFile, std::ios::app);
+        return SizeStatistic{0, 0, 0, 0, 0};
+    }
+    std::vector<std::size_t> offsets;
+    std::size_t indexBegin = 0;
+    std::unique_ptr<Encoding> previous;
+    if (archiveFileSize != 0) {
+        std::ifstream in(archiveFile);
+        checkInputFileExistence(in, archiveFile);
+        offsets = readIndex(in, archiveFile, archiveFileSize, indexBegin);
+        previous = std::make_unique<Encoding>(headerEncoding(readLastTable(in, archiveFile, offsets)));
+    }
+    bool repeatTable;
+    auto encoding = chooseEncoding(input, alphabet, previous.get(), repeatTable);
+    std::ofstream(archiveFile, std::ios::app); // creates archive if it doesn't exist
+    std::fstream out(archiveFile, std::ios::in | std::ios::out);
+    if (!out.is_open())
+        throw HuffmanLoadFileException(archiveFile);
     try {
-        writeUncompressedFile(InputBitStream(in, inputFile), outputFile, header.size, tree);
-    } catch (const HuffmanLogicError& e) {
-        throw HuffmanInvalidCompressedFile(inputFile);
+        out.seekp(archiveFileSize);
+        auto statistic = writeSegment(out, archiveFile, input, encoding, repeatTable);
+        offsets.push_back(archiveFileSize);
+        const auto newIndexBegin = out.tellp();
+        writeIndex(out, archiveFile, offsets);
+        statistic.headerSize += static_cast<std::size_t>(out.tellp() - newIndexBegin);
+        return statistic;
+    } catch (const HuffmanException& e) {
+        out.close();
+        std::filesystem::resize_file(archiveFile, archiveFileSize);
+        throw;
     }
-    const auto endFile = in.tellg();
-    return SizeStatistic{fileSize(outputFile),
-                         static_cast<std::size_t>(endFile - compressedPartBegin),
-                         static_cast<std::size_t>(compressedPartBegin - headerBegin)};
 }
 
+/** Alphabet realisation */
+std::size_t alphabetSize(Alphabet alphabet) {
+    return alphabet == Alphabet::BYTE ? byteAlphabetSize : pairAlphabetSize;
+}
+
+Word pairWord(uint8_t first, uint8_t second) {
+    return byteAlphabetSize + ((first << byteBits) | second);
+}
+
+bool isPairWord(Word word) {
+    return word >= byteAlphabetSize;
+}
+/** Alphabet end */
+
+/** WordReader realisation */
+bool WordReader::readByte(uint8_t &byte) {
+    if (hasNextByte) {
+        hasNextByte = false;
+        byte = nextByte;
+        return true;
+    }
+    if (chunkPos == chunkEnd) {
+        in.read(chunk.data(), std::min(chunk.size(), left));
+        chunkPos = 0;
+        chunkEnd = in.gcount();
+        left -= chunkEnd;
+        if (chunkEnd == 0)
+            return false;
+    }
+    byte = chunk[chunkPos++];
+    return true;
+}
+
+bool WordReader::read(Word &word) {
+    uint8_t first;
+    if (!readByte(first))
+        return false;
+    word = first;
+    if (pairs.empty() || !readByte(nextByte))
+        return true;
+    if (pairs[(first << byteBits) | nextByte]) {
+        word = pairWord(first, nextByte);
+    } else {
+        hasNextByte = true;
+    }
+    return true;
+}
+/** WordReader end */
+
 /** Table realisation */
-Table::Table(std::initializer_list<std::pair<uint8_t, std::vector<bool>>> list) {
+Table::Table() : data_(byteAlphabetSize) {}
+
+Table::Table(std::size_t alphabetSize) : data_(alphabetSize) {}
+
+Table::Table(std::initializer_list<std::pair<Word, std::vector<bool>>> list) : data_(byteAlphabetSize) {
     for (auto& elem : list) {
-        data_[elem.first] = elem.second;
+        (*this)[elem.first] = elem.second;
     }
 }
 
-std::vector<bool> & Table::operator[](uint8_t id) {
+std::vector<bool> & Table::operator[](Word id) {
+    if (id >= data_.size())
+        throw HuffmanLogicError();
     return data_[id];
 }
 
-const std::vector<bool> & Table::at(uint8_t id) const {
-    if (data_[id].empty())
+const std::vector<bool> & Table::at(Word id) const {
+    if (id >= data_.size() || data_[id].empty())
         throw HuffmanLogicError();
     return data_[id];
 }
 
+const std::vector<bool> & Table::code(Word id) const {
+    return data_[id];
+}
+
+std::size_t Table::size() const {
+    return data_.size();
+}
+
 bool Table::operator==(const Table &other) const {
-    for (std::size_t i = 0; i < maxByte; i++) {
-        if (!(data_[i] == other.data_[i]))
-            return false;
-    }
-    return true;
+    return data_ == other.data_;
 }
 /** Table end */
 
@@ -205,14 +582,14 @@ const Node* Tree::getRoot() const {
     return root.get();
 }
 
-const Node* Tree::go(const Node* node, bool bit) {
+const Node* Tree::go(const Node* node, bool bit) const {
     if ((bit && node->next1 == nullptr) || (!bit && node->next0 == nullptr))
         throw HuffmanLogicError();
     return (bit ? node->next1 : node->next0).get();
 }
 
-Table Tree::getTable() const {
-    Table table;
+Table Tree::getTable(std::size_t alphabetSize) const {
+    Table table(alphabetSize);
     std::vector<bool> path(0);
     dfs(root.get(), path, table);
     return table;
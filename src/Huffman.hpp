@@ -16,29 +16,48 @@
 
 namespace huffman {
 
+using Word = uint32_t;
+
 const int maxByte = std::numeric_limits<uint8_t>::max();
+const std::size_t byteAlphabetSize = maxByte + 1;
+const std::size_t pairAlphabetSize = byteAlphabetSize + byteAlphabetSize * byteAlphabetSize;
+
+/** Alphabet of coded words: single bytes only, or single bytes together with frequent byte pairs */
+enum class Alphabet {
+    BYTE,
+    BYTE_PAIR
+};
+
+std::size_t alphabetSize(Alphabet alphabet);
+Word pairWord(uint8_t first, uint8_t second);
+bool isPairWord(Word word);
 
 class Table {
 public:
-    Table() = default;
-    Table(std::initializer_list<std::pair<uint8_t, std::vector<bool>>> list);
-    std::vector<bool>& operator[] (uint8_t id);
-    const std::vector<bool>& at(uint8_t id) const;
+    Table();
+    explicit Table(std::size_t alphabetSize);
+    Table(std::initializer_list<std::pair<Word, std::vector<bool>>> list);
+    std::vector<bool>& operator[] (Word id); // throws HuffmanLogicError if id is out of alphabet
+    const std::vector<bool>& at(Word id) const;
+    const std::vector<bool>& code(Word id) const; // empty if there is no such word
+    std::size_t size() const;
     bool operator == (const Table& other) const; // for tests
 
 private:
-    std::vector<bool> data_[maxByte + 1];
+    std::vector<std::vector<bool>> data_;
 };
 
 struct SizeStatistic {
     std::size_t originalSize;
     std::size_t compressedSize;
     std::size_t headerSize;
+    std::size_t segments = 1;
+    std::size_t tablesReused = 0; // segments that repeat the table of the previous one
 };
 
 struct WordStatistic {
-    explicit WordStatistic(uint8_t word_, std::size_t stat_ = 0) : word(word_), stat(stat_) {}
-    uint8_t word;
+    explicit WordStatistic(Word word_, std::size_t stat_ = 0) : word(word_), stat(stat_) {}
+    Word word;
     std::size_t stat;
 };
 
@@ -46,29 +65,53 @@ struct Node {
     const std::unique_ptr<const Node> next0;
     const std::unique_ptr<const Node> next1;
     const bool terminalFlag = false;
-    const uint8_t word = 0;
+    const Word word = 0;
 };
 
 class Tree {
 public:
     explicit Tree(const std::vector<WordStatistic>& statistic);
-    const Node* go(const Node* node, bool bit);
+    const Node* go(const Node* node, bool bit) const;
     const Node* getRoot() const;
-    Table getTable() const;
+    Table getTable(std::size_t alphabetSize) const;
 
 private:
     void dfs(const Node* node, std::vector<bool>& curPath, Table& table) const;
     std::unique_ptr<const Node> root;
 };
 
-/** Header of compressed file */
+/** Header of compressed file or of one segment of appended archive */
 struct Header {
     std::size_t size; // compressed file size in bits
+    Alphabet alphabet = Alphabet::BYTE;
+    bool repeatTable = false; // statistic of the previous segment is used
     std::vector<WordStatistic> statistic;
 };
 
-SizeStatistic code(std::string inputFile, std::string outputFile);
+/** Splits input into words: a pair of bytes marked in pairs is read as one word, any other byte is read alone */
+class WordReader {
+public:
+    WordReader(std::istream &in_, const std::vector<bool> &pairs_, std::size_t limit_ = std::numeric_limits<std::size_t>::max())
+            : in(in_), pairs(pairs_), left(limit_), chunk(chunkSize) {}
+    bool read(Word &word);
+
+private:
+    static const std::size_t chunkSize = 1 << 16;
+    bool readByte(uint8_t &byte);
+    std::istream &in;
+    const std::vector<bool> &pairs;
+    uint8_t nextByte = 0;
+    bool hasNextByte = false;
+    std::size_t left; // bytes which may be read from stream
+    std::vector<char> chunk;
+    std::size_t chunkPos = 0;
+    std::size_t chunkEnd = 0;
+};
+
+/** Codes blocks of blockSize bytes as separate segments if blockSize isn't zero */
+SizeStatistic code(std::string inputFile, std::string outputFile, Alphabet alphabet = Alphabet::BYTE, std::size_t blockSize = 0);
 SizeStatistic decode(std::string inputFile, std::string outputFile);
+SizeStatistic append(std::string inputFile, std::string archiveFile, Alphabet alphabet = Alphabet::BYTE);
 
 }
 
@@ -0,0 +1,86 @@
+#include "HuffmanKernels.hpp"
+
+namespace huffman {
+
+std::size_t maxCodeLength(const Table& table) {
+    std::size_t length = 0;
+    for (Word word = 0; word < table.size(); word++) {
+        length = std::max(length, table.code(word).size());
+    }
+    return length;
+}
+
+std::vector<PackedCode> packCodes(const Table& table) {
+    std::vector<PackedCode> codes(table.size());
+    for (Word word = 0; word < table.size(); word++) {
+        const auto& code = table.code(word);
+        for (std::size_t pos = 0; pos < code.size(); pos++) {
+            codes[word].bits |= static_cast<uint64_t>(code[pos]) << pos;
+        }
+        codes[word].length = code.size();
+    }
+    return codes;
+}
+
+void writeWords(WordReader& reader, OutputBitStream outStream, const Table& table) {
+    Word word;
+    while (reader.read(word)) {
+        outStream.write(table.at(word));
+    }
+    outStream.close();
+}
+
+void readWords(InputBitStream inStream, std::ostream& out, std::size_t fileSize, const Tree& tree) {
+    const Node* curNode = tree.getRoot();
+    for (std::size_t pos = 0; pos < fileSize; pos++) {
+        curNode = tree.go(curNode, inStream.readBit());
+        if (curNode->terminalFlag) {
+            Word word = curNode->word;
+            curNode = tree.getRoot();
+            if (isPairWord(word)) {
+                uint8_t bytes[2] = {static_cast<uint8_t>((word - byteAlphabetSize) >> byteBits),
+                                    static_cast<uint8_t>(word - byteAlphabetSize)};
+                out.write(reinterpret_cast<char *>(bytes), sizeof bytes);
+            } else {
+                uint8_t byte = word;
+                out.write(reinterpret_cast<char *>(&byte), sizeof byte);
+            }
+        }
+    }
+    if (curNode != tree.getRoot()) {
+        throw HuffmanLogicError();
+    }
+}
+
+Lookup buildLookup(const Tree& tree, int lookupBits) {
+    Lookup lookup;
+    lookup.entries.resize(std::size_t(1) << lookupBits);
+    for (std::size_t bits = 0; bits < lookup.entries.size(); bits++) {
+        LookupEntry& entry = lookup.entries[bits];
+        const Node* node = tree.getRoot();
+        int length = 0;
+        while (node != nullptr && !node->terminalFlag && length < lookupBits) {
+            node = (((bits >> length) & 1) ? node->next1 : node->next0).get();
+            length++;
+        }
+        if (node == nullptr)
+            continue;
+        entry.length = length;
+        if (!node->terminalFlag) { // path of lookupBits bits leads to a single node, so escapes are unique
+            const std::size_t escapeId = lookup.escapes.size();
+            lookup.escapes.push_back(node);
+            entry.bytes[0] = escapeId;
+            entry.bytes[1] = escapeId >> byteBits;
+        } else if (isPairWord(node->word)) {
+            entry.byteCount = 2;
+            entry.bytes[0] = (node->word - byteAlphabetSize) >> byteBits;
+            entry.bytes[1] = node->word - byteAlphabetSize;
+        } else {
+            entry.byteCount = 1;
+            entry.bytes[0] = node->word;
+        }
+    }
+    return lookup;
+}
+
+}
@@ -0,0 +1,214 @@
+#ifndef HW_02_HUFFMANKERNELS_HPP
+#define HW_02_HUFFMANKERNELS_HPP
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <limits>
+#include <istream>
+#include <ostream>
+#include "Huffman.hpp"
+
+namespace huffman {
+
+const std::size_t kernelChunkSize = 1 << 16;
+
+/** Code of a word packed into integer, the first bit of the code is the lowest one */
+struct PackedCode {
+    uint64_t bits = 0;
+    uint8_t length = 0;
+};
+
+/**
+ * Word decoded from the lowest bits of the stream, zero length means that there is no such code.
+ * Zero byteCount means that the code is longer than lookup: then bytes keep index of the escape node,
+ * from which decoding continues bit by bit after length bits.
+ */
+struct LookupEntry {
+    uint8_t length = 0;
+    uint8_t byteCount = 0;
+    uint8_t bytes[2] = {0, 0};
+};
+
+/** Lookup by the lowest lookupBits bits of the stream, nodes are owned by the tree it was built from */
+struct Lookup {
+    std::vector<LookupEntry> entries;
+    std::vector<const Node*> escapes;
+};
+
+std::size_t maxCodeLength(const Table& table);
+std::vector<PackedCode> packCodes(const Table& table);
+Lookup buildLookup(const Tree& tree, int lookupBits);
+
+/** Generic bit by bit coding, used when codes are too long for kernels */
+void writeWords(WordReader& reader, OutputBitStream outStream, const Table& table);
+void readWords(InputBitStream inStream, std::ostream& out, std::size_t fileSize, const Tree& tree);
+
+template <typename BitBuffer>
+constexpr std::array<BitBuffer, std::numeric_limits<BitBuffer>::digits + 1> lowBitsMasks() {
+    std::array<BitBuffer, std::numeric_limits<BitBuffer>::digits + 1> masks{};
+    for (int count = 1; count <= std::numeric_limits<BitBuffer>::digits; count++) {
+        masks[count] = static_cast<BitBuffer>((masks[count - 1] << 1) | 1);
+    }
+    return masks;
+}
+
+/**
+ * Writes codes of all words from reader, codes must be not longer than MaxCodeLength.
+ * Output is the same as of OutputBitStream, but bytes are flushed in fixed size groups:
+ * before a code is added less than flushBits bits are buffered, so the code always fits into buffer.
+ */
+template <typename BitBuffer, int MaxCodeLength>
+void encodeWords(WordReader& reader, std::ostream& out, const std::string& outputFile, const std::vector<PackedCode>& codes) {
+    constexpr int bufferBits = std::numeric_limits<BitBuffer>::digits;
+    constexpr int flushBytes = (bufferBits - MaxCodeLength) / byteBits;
+    constexpr int flushBits = flushBytes * byteBits;
+    static_assert(flushBytes > 0 && flushBits + MaxCodeLength <= bufferBits, "Bit buffer is too small for such codes");
+
+    std::vector<char> chunk(kernelChunkSize + 2 * sizeof(BitBuffer));
+    std::size_t chunkPos = 0;
+    BitBuffer buffer = 0;
+    int count = 0;
+    Word word;
+    while (reader.read(word)) {
+        const PackedCode code = codes[word];
+        buffer |= static_cast<BitBuffer>(code.bits) << count;
+        count += code.length;
+        while (count >= flushBits) {
+            for (int i = 0; i < flushBytes; i++) {
+                chunk[chunkPos++] = static_cast<char>(buffer >> (i * byteBits));
+            }
+            buffer >>= flushBits;
+            count -= flushBits;
+        }
+        if (chunkPos >= kernelChunkSize) {
+            if (!out.write(chunk.data(), chunkPos))
+                throw HuffmanWriteFileException(outputFile);
+            chunkPos = 0;
+        }
+    }
+    for (; count > 0; count -= byteBits) {
+        chunk[chunkPos++] = static_cast<char>(buffer);
+        buffer >>= byteBits;
+    }
+    if (!out.write(chunk.data(), chunkPos))
+        throw HuffmanWriteFileException(outputFile);
+}
+
+/** Reads bytes of the compressed part, at most size bytes in total */
+class ChunkReader {
+public:
+    ChunkReader(std::istream &in_, std::string fileName_, std::size_t size_)
+            : in(in_), fileName(std::move(fileName_)), left(size_), chunk(kernelChunkSize) {}
+
+    template <typename BitBuffer>
+    void refill(BitBuffer &buffer, int &count) {
+        while (count <= std::numeric_limits<BitBuffer>::digits - byteBits) {
+            if (chunkPos == chunkEnd && !nextChunk())
+                return;
+            buffer |= static_cast<BitBuffer>(static_cast<uint8_t>(chunk[chunkPos++])) << count;
+            count += byteBits;
+        }
+    }
+
+private:
+    bool nextChunk() {
+        if (left == 0)
+            return false;
+        chunkEnd = std::min(left, chunk.size());
+        if (!in.read(chunk.data(), chunkEnd))
+            throw HuffmanInvalidCompressedFile(fileName);
+        left -= chunkEnd;
+        chunkPos = 0;
+        return true;
+    }
+
+    std::istream &in;
+    const std::string fileName;
+    std::size_t left;
+    std::vector<char> chunk;
+    std::size_t chunkPos = 0;
+    std::size_t chunkEnd = 0;
+};
+
+/**
+ * Decodes size bits of the compressed part, every word not longer than LookupBits is decoded with one lookup.
+ * Longer words continue through the tree from escape node, after them the group of words is restarted,
+ * because the buffer may have less bits than the group needs.
+ */
+template <int LookupBits, typename BitBuffer>
+void decodeWords(std::istream& in, const std::string& inputFile, std::ostream& out, const std::string& outputFile,
+                 std::size_t size, const Lookup& lookup) {
+    constexpr int bufferBits = std::numeric_limits<BitBuffer>::digits;
+    constexpr int wordsPerRefill = (bufferBits - byteBits + 1) / LookupBits;
+    constexpr BitBuffer lookupMask = lowBitsMasks<BitBuffer>()[LookupBits];
+    static_assert(wordsPerRefill > 0, "Bit buffer is too small for such lookup");
+    static_assert(LookupBits <= 2 * byteBits, "Escape index doesn't fit into lookup entry");
+
+    ChunkReader reader(in, inputFile, (size + byteBits - 1) / byteBits);
+    std::vector<char> chunk(kernelChunkSize + 2 * wordsPerRefill * LookupBits + 2);
+    std::size_t chunkPos = 0;
+    BitBuffer buffer = 0;
+    int count = 0;
+    std::size_t left = size;
+    auto decodeLongWord = [&](const LookupEntry& entry) {
+        const Node* node = lookup.escapes[entry.bytes[0] | (entry.bytes[1] << byteBits)];
+        while (!node->terminalFlag) {
+            if (left == 0)
+                throw HuffmanLogicError();
+            if (count == 0)
+                reader.refill(buffer, count);
+            node = ((buffer & 1) ? node->next1 : node->next0).get();
+            if (node == nullptr)
+                throw HuffmanLogicError();
+            buffer >>= 1;
+            count--;
+            left--;
+        }
+        if (isPairWord(node->word)) {
+            chunk[chunkPos++] = static_cast<char>((node->word - byteAlphabetSize) >> byteBits);
+            chunk[chunkPos++] = static_cast<char>(node->word - byteAlphabetSize);
+        } else {
+            chunk[chunkPos++] = static_cast<char>(node->word);
+        }
+    };
+    // returns false if the word was long
+    auto decodeWord = [&]() {
+        const LookupEntry entry = lookup.entries[buffer & lookupMask];
+        if (entry.length == 0)
+            throw HuffmanLogicError();
+        buffer >>= entry.length;
+        count -= entry.length;
+        left -= entry.length;
+        if (entry.byteCount == 0) {
+            decodeLongWord(entry);
+            return false;
+        }
+        chunk[chunkPos] = static_cast<char>(entry.bytes[0]);
+        chunk[chunkPos + 1] = static_cast<char>(entry.bytes[1]);
+        chunkPos += entry.byteCount;
+        return true;
+    };
+    while (left >= static_cast<std::size_t>(wordsPerRefill * LookupBits)) {
+        reader.refill(buffer, count);
+        for (int i = 0; i < wordsPerRefill && decodeWord(); i++) {}
+        if (chunkPos >= kernelChunkSize) {
+            if (!out.write(chunk.data(), chunkPos))
+                throw HuffmanWriteFileException(outputFile);
+            chunkPos = 0;
+        }
+    }
+    while (left > 0) {
+        reader.refill(buffer, count);
+        if (lookup.entries[buffer & lookupMask].length > left)
+            throw HuffmanLogicError();
+        decodeWord();
+    }
+    if (!out.write(chunk.data(), chunkPos))
+        throw HuffmanWriteFileException(outputFile);
+}
+
+}
+
+#endif //HW_02_HUFFMANKERNELS_HPP
@@ -10,6 +10,7 @@ using namespace huffman;
 enum taskType {
     CODE,
     DECODE,
+    APPEND,
     UNDEFINED
 };
 
@@ -18,6 +19,8 @@ struct Arguments {
     std::string outputFile;
     taskType type = UNDEFINED;
     bool timeFlag = false;
+    Alphabet alphabet = Alphabet::BYTE;
+    std::size_t blockSize = 0;
 };
 
 Arguments parse(int argc, char* argv[]) {
@@ -42,16 +45,32 @@ Arguments parse(int argc, char* argv[]) {
             i += 1;
             continue;
         }
-        if (arg == "-u" || arg == "-c") {
+        if (arg == "-u" || arg == "-c" || arg == "-a") {
             if (result.type != UNDEFINED)
                 throw std::invalid_argument("Too many tasks flags");
-            result.type = (arg == "-u") ? DECODE : CODE;
+            result.type = (arg == "-u") ? DECODE : (arg == "-a") ? APPEND : CODE;
             continue;
         }
         if (arg == "-t") {
             result.timeFlag = true;
             continue;
         }
+        if (arg == "-b" || arg == "--block") {
+            if (i == argc - 1)
+                throw std::invalid_argument("No size after -b flag");
+            std::string size(argv[i + 1]);
+            if (size.empty() || size.find_first_not_of("0123456789") != std::string::npos)
+                throw std::invalid_argument("Block size must be a positive number");
+            result.blockSize = std::stoull(size);
+            if (result.blockSize == 0)
+                throw std::invalid_argument("Block size must be a positive number");
+            i += 1;
+            continue;
+        }
+        if (arg == "-p" || arg == "--pairs") {
+            result.alphabet = Alphabet::BYTE_PAIR;
+            continue;
+        }
         throw std::invalid_argument("No such flag " + arg);
     }
     if (result.inputFile.empty())
@@ -60,6 +79,8 @@ Arguments parse(int argc, char* argv[]) {
         throw std::invalid_argument("Output file wasn't stated");
     if (result.type == UNDEFINED)
         throw std::invalid_argument("Task flag wasn't stated");
+    if (result.blockSize != 0 && result.type != CODE)
+        throw std::invalid_argument("-b flag is allowed only with -c");
     return result;
 }
 
@@ -75,11 +96,18 @@ int main(int argc,char* argv[]) {
     try {
         auto startTime = clock();
         if (arguments.type == CODE) {
-            auto statisticSize = code(arguments.inputFile, arguments.outputFile);
+            auto statisticSize = code(arguments.inputFile, arguments.outputFile, arguments.alphabet, arguments.blockSize);
+            std::cout << statisticSize.originalSize << std::endl << statisticSize.compressedSize << std::endl;
+            if (arguments.blockSize != 0)
+                std::cout << "Tables reused: " << statisticSize.tablesReused << " of " << statisticSize.segments << std::endl;
+        } else if (arguments.type == APPEND) {
+            auto statisticSize = append(arguments.inputFile, arguments.outputFile, arguments.alphabet);
             std::cout << statisticSize.originalSize << std::endl << statisticSize.compressedSize << std::endl;
         } else {
             auto statisticSize = decode(arguments.inputFile, arguments.outputFile);
             std::cout << statisticSize.compressedSize << std::endl << statisticSize.originalSize << std::endl;
+            if (statisticSize.segments > 1)
+                std::cout << "Tables reused: " << statisticSize.tablesReused << " of " << statisticSize.segments << std::endl;
         }
         auto endTime = clock();
         if (arguments.timeFlag)
@@ -8,7 +8,9 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 #include <filesystem>
+#include <sstream>
 #include "Huffman.hpp"
+#include "HuffmanKernels.hpp"
 
 using namespace huffman;
 
@@ -25,8 +27,9 @@ void removeFile(std::string fileName) {
     std::filesystem::remove(fileName);
 }
 
-void codeAndDecodeCheck(std::string fileName, bool specialStatisticCheck = false, SizeStatistic specialStatistic = SizeStatistic {0, 0, 0}) {
-    auto codeStatistic = code(pathToResources(fileName), pathToResources("testTmp.txt"));
+void codeAndDecodeCheck(std::string fileName, bool specialStatisticCheck = false, SizeStatistic specialStatistic = SizeStatistic {0, 0, 0},
+                        Alphabet alphabet = Alphabet::BYTE) {
+    auto codeStatistic = code(pathToResources(fileName), pathToResources("testTmp.txt"), alphabet);
     auto decodeStatistic = decode(pathToResources("testTmp.txt"), pathToResources("out.txt"));
     CHECK(system(("diff " + pathToResources(fileName) + " " + pathToResources("out.txt")).c_str()) == 0);
     CHECK(statisticEq(codeStatistic, decodeStatistic));
@@ -74,9 +77,12 @@ TEST_CASE("Tree") {
     }
 
     SUBCASE("getTable") {
-        CHECK_EQ(Table{{'A', std::vector<bool> {0}}}, tree2.getTable());
+        CHECK_EQ(Table{{'A', std::vector<bool> {0}}}, tree2.getTable(byteAlphabetSize));
         CHECK_EQ(Table{{'a', std::vector<bool> {0}}, {'b', std::vector<bool>{1, 0}}, {'c', std::vector<bool>{1, 1}}},
-                 tree1.getTable());
+                 tree1.getTable(byteAlphabetSize));
+        Tree pairTree(std::vector<WordStatistic> {WordStatistic('a', 5), WordStatistic(pairWord('a', 'b'), 3)});
+        CHECK_THROWS_AS(pairTree.getTable(byteAlphabetSize), const HuffmanLogicError&);
+        CHECK_EQ(pairTree.getTable(pairAlphabetSize).at(pairWord('a', 'b')), std::vector<bool> {0});
     }
 
     SUBCASE("go") {
@@ -147,6 +153,333 @@ TEST_CASE("empty file") {
     codeAndDecodeCheck("empty.txt", true);
 }
 
+TEST_CASE("code and decode byte pairs") {
+    codeAndDecodeCheck("sample_01.txt", false, {0, 0, 0}, Alphabet::BYTE_PAIR);
+    codeAndDecodeCheck("InputStreamSample.txt", false, {0, 0, 0}, Alphabet::BYTE_PAIR);
+    codeAndDecodeCheck("faust.txt", false, {0, 0, 0}, Alphabet::BYTE_PAIR);
+    codeAndDecodeCheck("empty.txt", true, {0, 0, 0}, Alphabet::BYTE_PAIR);
+}
+
+void writeFile(std::string fileName, std::string content) {
+    std::ofstream out(fileName);
+    out << content;
+}
+
+/** Checks the pair alphabet flag in the header of the segment which begins at offset */
+bool pairAlphabetHeader(std::string archive, std::size_t offset = 0) {
+    std::ifstream in(archive);
+    std::size_t statisticSize = 0;
+    in.seekg(offset + sizeof(std::size_t));
+    in.read(reinterpret_cast<char *>(&statisticSize), sizeof statisticSize);
+    return statisticSize >> (std::numeric_limits<std::size_t>::digits - 1);
+}
+
+TEST_CASE("byte pairs format") {
+    const std::string pairs = pathToResources("pairs.txt");
+    const std::string archive = pathToResources("testTmp.txt");
+    const std::string out = pathToResources("out.txt");
+    std::string content;
+    for (int i = 0; i < 1000; i++) {
+        content += "ab";
+    }
+    writeFile(pairs, content + "xyz");
+
+    SUBCASE("code") {
+        auto byteStatistic = code(pairs, archive);
+        CHECK(!pairAlphabetHeader(archive));
+        auto codeStatistic = code(pairs, archive, Alphabet::BYTE_PAIR);
+        CHECK(pairAlphabetHeader(archive));
+        CHECK(codeStatistic.compressedSize < byteStatistic.compressedSize);
+        auto decodeStatistic = decode(archive, out);
+        CHECK(statisticEq(codeStatistic, decodeStatistic));
+        CHECK(system(("diff " + pairs + " " + out).c_str()) == 0);
+
+        auto appendStatistic = append(pairs, archive, Alphabet::BYTE_PAIR);
+        CHECK(appendStatistic.tablesReused == 1);
+        const std::string twice = pathToResources("pairsTwice.txt");
+        writeFile(twice, content + "xyz" + content + "xyz");
+        decode(archive, out);
+        CHECK(system(("diff " + twice + " " + out).c_str()) == 0);
+        removeFile(twice);
+    }
+
+    SUBCASE("blocks") {
+        auto codeStatistic = code(pairs, archive, Alphabet::BYTE_PAIR, 500);
+        CHECK(pairAlphabetHeader(archive));
+        CHECK(codeStatistic.segments == 5);
+        CHECK(codeStatistic.tablesReused == 3);
+        auto decodeStatistic = decode(archive, out);
+        CHECK(statisticEq(codeStatistic, decodeStatistic));
+        CHECK(decodeStatistic.tablesReused == 3);
+        CHECK(system(("diff " + pairs + " " + out).c_str()) == 0);
+    }
+
+    removeFile(pairs);
+    removeFile(archive);
+    removeFile(out);
+}
+
+TEST_CASE("code and decode blocks") {
+    const std::string archive = pathToResources("testTmp.txt");
+    const std::string out = pathToResources("out.txt");
+    const std::string mixed = pathToResources("mixed.txt");
+    CHECK(system(("cat " + pathToResources("sample_01.txt") + " " + pathToResources("sample_01.txt") + " "
+                  + pathToResources("InputStreamSample.txt") + " > " + mixed).c_str()) == 0);
+
+    SUBCASE("repeated table") {
+        auto codeStatistic = code(pathToResources("sample_01.txt"), archive, Alphabet::BYTE, 40);
+        auto decodeStatistic = decode(archive, out);
+        CHECK(system(("diff " + pathToResources("sample_01.txt") + " " + out).c_str()) == 0);
+        CHECK(statisticEq(codeStatistic, decodeStatistic));
+        CHECK(codeStatistic.segments == 5);
+        CHECK(decodeStatistic.segments == 5);
+        CHECK(codeStatistic.tablesReused == 1);
+        CHECK(decodeStatistic.tablesReused == 1);
+    }
+
+    SUBCASE("changing distribution") {
+        for (auto alphabet : {Alphabet::BYTE, Alphabet::BYTE_PAIR}) {
+            auto codeStatistic = code(mixed, archive, alphabet, 161);
+            auto decodeStatistic = decode(archive, out);
+            CHECK(system(("diff " + mixed + " " + out).c_str()) == 0);
+            CHECK(statisticEq(codeStatistic, decodeStatistic));
+            CHECK(codeStatistic.segments == 3);
+            CHECK(codeStatistic.tablesReused == 1);
+            CHECK(decodeStatistic.tablesReused == 1);
+        }
+    }
+
+    removeFile(archive);
+    removeFile(out);
+    removeFile(mixed);
+}
+
+TEST_CASE("append") {
+    const std::string archive = pathToResources("testTmp.txt");
+    const std::string expected = pathToResources("expected.txt");
+    const std::string out = pathToResources("out.txt");
+
+    SUBCASE("to coded file") {
+        code(pathToResources("sample_01.txt"), archive);
+        CHECK(append(pathToResources("InputStreamSample.txt"), archive).originalSize == 26);
+        append(pathToResources("empty.txt"), archive);
+        const std::string before = pathToResources("before.txt");
+        CHECK(system(("cp " + archive + " " + before).c_str()) == 0);
+        append(pathToResources("sample_01.txt"), archive, Alphabet::BYTE_PAIR);
+        // old segments and index stay untouched
+        CHECK(system(("head -c $(wc -c < " + before + ") " + archive + " | cmp -s - " + before).c_str()) == 0);
+        removeFile(before);
+        auto repeatStatistic = append(pathToResources("sample_01.txt"), archive);
+        // repeat header and index of four segments
+        CHECK(repeatStatistic.headerSize == 2 * sizeof(std::size_t) + (4 + 2) * sizeof(std::size_t));
+        CHECK(system(("cat " + pathToResources("sample_01.txt") + " " + pathToResources("InputStreamSample.txt") + " "
+                      + pathToResources("sample_01.txt") + " " + pathToResources("sample_01.txt") + " > " + expected).c_str()) == 0);
+    }
+
+    SUBCASE("to nonexistent file") {
+        removeFile(archive);
+        append(pathToResources("InputStreamSample.txt"), archive);
+        append(pathToResources("sample_01.txt"), archive);
+        CHECK(system(("cat " + pathToResources("InputStreamSample.txt") + " " + pathToResources("sample_01.txt")
+                      + " > " + expected).c_str()) == 0);
+    }
+
+    decode(archive, out);
+    CHECK(system(("diff " + expected + " " + out).c_str()) == 0);
+    removeFile(archive);
+    removeFile(expected);
+    removeFile(out);
+}
+
+TEST_CASE("WordReader") {
+    std::istringstream in("abababc");
+    std::vector<bool> pairs(byteAlphabetSize * byteAlphabetSize, false);
+    pairs[('b' << byteBits) | 'a'] = true;
+    WordReader reader(in, pairs);
+    std::vector<Word> words;
+    Word word;
+    while (reader.read(word)) {
+        words.push_back(word);
+    }
+    CHECK_EQ(words, std::vector<Word> {'a', pairWord('b', 'a'), pairWord('b', 'a'), 'b', 'c'});
+    CHECK(isPairWord(pairWord(0, 0)));
+    CHECK(!isPairWord(maxByte));
+}
+
+std::string packBits(const std::vector<bool>& bits) {
+    std::string bytes((bits.size() + byteBits - 1) / byteBits, 0);
+    for (std::size_t pos = 0; pos < bits.size(); pos++) {
+        bytes[pos / byteBits] |= static_cast<char>(bits[pos] << (pos % byteBits));
+    }
+    return bytes;
+}
+
+std::vector<WordStatistic> fibonacciStatistic(Word count) {
+    std::vector<WordStatistic> statistic;
+    std::size_t stat1 = 1, stat2 = 1;
+    for (Word word = 0; word < count; word++) {
+        statistic.emplace_back(word, stat1);
+        stat2 = stat1 + stat2;
+        stat1 = stat2 - stat1;
+    }
+    return statistic;
+}
+
+/** Every word of statistic from 1 to 3 times in a row, several times */
+std::string fibonacciText(Word count) {
+    std::string text;
+    for (int repeat = 0; repeat < 3; repeat++) {
+        for (Word word = 0; word < count; word++) {
+            text += std::string(word % 3 + 1, static_cast<char>(word));
+        }
+    }
+    return text;
+}
+
+TEST_CASE("Kernels") {
+    const Tree tree(std::vector<WordStatistic> {WordStatistic('a', 5), WordStatistic('b', 3), WordStatistic('c', 4)});
+    const Table table = tree.getTable(byteAlphabetSize);
+    const std::vector<bool> noPairs;
+    const std::string text = "abcabcaabbccacbcaaab";
+    std::vector<bool> bits;
+    for (char c : text) {
+        auto code = table.at(c);
+        bits.insert(bits.end(), code.begin(), code.end());
+    }
+
+    SUBCASE("codes") {
+        CHECK(maxCodeLength(table) == 2);
+        auto codes = packCodes(table);
+        CHECK(codes['a'].bits == 0);
+        CHECK(codes['b'].bits == 1);
+        CHECK(codes['c'].bits == 3);
+        CHECK(codes['c'].length == 2);
+        CHECK(codes['d'].length == 0);
+    }
+
+    SUBCASE("encode") {
+        std::istringstream in1(text), in2(text);
+        WordReader reader1(in1, noPairs), reader2(in2, noPairs);
+        std::ostringstream out1, out2;
+        encodeWords<uint64_t, 32>(reader1, out1, "out1", packCodes(table));
+        encodeWords<uint32_t, 16>(reader2, out2, "out2", packCodes(table));
+        CHECK_EQ(out1.str(), packBits(bits));
+        CHECK_EQ(out2.str(), packBits(bits));
+    }
+
+    SUBCASE("encode long codes") {
+        const Table longTable = Tree(fibonacciStatistic(40)).getTable(byteAlphabetSize);
+        CHECK(maxCodeLength(longTable) > 32);
+        CHECK(maxCodeLength(longTable) <= 56);
+        const std::string longText = fibonacciText(40);
+        std::ostringstream expected;
+        OutputBitStream outStream(expected, "expected");
+        for (char c : longText) {
+            outStream.write(longTable.at(static_cast<uint8_t>(c)));
+        }
+        outStream.close();
+        std::istringstream in(longText);
+        WordReader reader(in, noPairs);
+        std::ostringstream out;
+        encodeWords<uint64_t, 56>(reader, out, "out", packCodes(longTable));
+        CHECK_EQ(out.str(), expected.str());
+
+        std::istringstream shortIn(text);
+        WordReader shortReader(shortIn, noPairs);
+        std::ostringstream shortExpected, shortOut;
+        OutputBitStream shortStream(shortExpected, "shortExpected");
+        shortStream.write(bits);
+        shortStream.close();
+        encodeWords<uint64_t, 32>(shortReader, shortOut, "shortOut", packCodes(table));
+        CHECK_EQ(shortOut.str(), shortExpected.str());
+    }
+
+    SUBCASE("decode") {
+        std::istringstream in1(packBits(bits)), in2(packBits(bits)), in3(packBits(bits));
+        std::ostringstream out1, out2, out3;
+        decodeWords<8, uint64_t>(in1, "in1", out1, "out1", bits.size(), buildLookup(tree, 8));
+        decodeWords<16, uint64_t>(in2, "in2", out2, "out2", bits.size(), buildLookup(tree, 16));
+        decodeWords<4, uint32_t>(in3, "in3", out3, "out3", bits.size(), buildLookup(tree, 4));
+        CHECK_EQ(out1.str(), text);
+        CHECK_EQ(out2.str(), text);
+        CHECK_EQ(out3.str(), text);
+    }
+
+    SUBCASE("decode long codes") {
+        const Tree longTree(fibonacciStatistic(40));
+        const Table longTable = longTree.getTable(byteAlphabetSize);
+        CHECK(maxCodeLength(longTable) > 16);
+        const std::string longText = fibonacciText(40);
+        std::vector<bool> longBits;
+        for (char c : longText) {
+            auto code = longTable.at(static_cast<uint8_t>(c));
+            longBits.insert(longBits.end(), code.begin(), code.end());
+        }
+        std::istringstream in1(packBits(longBits)), in2(packBits(longBits)), in3(packBits(longBits));
+        std::ostringstream out1, out2, out3;
+        decodeWords<8, uint64_t>(in1, "in1", out1, "out1", longBits.size(), buildLookup(longTree, 8));
+        decodeWords<11, uint64_t>(in2, "in2", out2, "out2", longBits.size(), buildLookup(longTree, 11));
+        decodeWords<16, uint64_t>(in3, "in3", out3, "out3", longBits.size(), buildLookup(longTree, 16));
+        CHECK_EQ(out1.str(), longText);
+        CHECK_EQ(out2.str(), longText);
+        CHECK_EQ(out3.str(), longText);
+
+        std::istringstream truncated(packBits(longBits));
+        std::ostringstream out;
+        const std::size_t insideLongCode = longTable.at(0).size() - 1; // text begins with the longest code
+        CHECK_THROWS_AS((decodeWords<8, uint64_t>(truncated, "truncated", out, "out", insideLongCode, buildLookup(longTree, 8))),
+                        const HuffmanLogicError&);
+    }
+
+    SUBCASE("pair words") {
+        std::vector<WordStatistic> pairStatistic;
+        std::vector<bool> pairs(byteAlphabetSize * byteAlphabetSize, false);
+        std::string pairText;
+        for (auto wordStat : fibonacciStatistic(20)) {
+            const uint8_t first = 'a' + wordStat.word;
+            pairStatistic.emplace_back(pairWord(first, 'b'), wordStat.stat);
+            pairs[(first << byteBits) | 'b'] = true;
+            pairText += std::string(1, first) + "b";
+        }
+        pairStatistic.emplace_back('z', 1);
+        pairText += "z" + pairText;
+        const Tree pairTree(pairStatistic);
+        const Table pairTable = pairTree.getTable(pairAlphabetSize);
+        CHECK(maxCodeLength(pairTable) > 8);
+        const auto lookup = buildLookup(pairTree, 8);
+        const auto frequentCode = packCodes(pairTable)[pairWord('a' + 19, 'b')];
+        CHECK(frequentCode.length <= 8);
+        CHECK(lookup.entries[frequentCode.bits].byteCount == 2);
+
+        std::istringstream in(pairText);
+        WordReader reader(in, pairs);
+        std::ostringstream encoded;
+        encodeWords<uint64_t, 32>(reader, encoded, "encoded", packCodes(pairTable));
+        std::size_t size = 0;
+        std::istringstream countIn(pairText);
+        WordReader countReader(countIn, pairs);
+        Word word;
+        while (countReader.read(word)) {
+            size += pairTable.at(word).size();
+        }
+
+        std::istringstream in1(encoded.str()), in2(encoded.str());
+        std::ostringstream out1, out2;
+        decodeWords<8, uint64_t>(in1, "in1", out1, "out1", size, lookup);
+        readWords(InputBitStream(in2, "in2"), out2, size, pairTree);
+        CHECK_EQ(out1.str(), pairText);
+        CHECK_EQ(out2.str(), pairText);
+    }
+
+    SUBCASE("decode invalid") {
+        const Tree singleTree(std::vector<WordStatistic> {WordStatistic('A', 100)});
+        std::istringstream in1(std::string(1, 2)), in2(std::string(1, 0));
+        std::ostringstream out;
+        CHECK_THROWS_AS((decodeWords<8, uint64_t>(in1, "in1", out, "out", 2, buildLookup(singleTree, 8))), const HuffmanLogicError&);
+        CHECK_THROWS_AS((decodeWords<8, uint64_t>(in2, "in2", out, "out", 9, buildLookup(singleTree, 8))), const HuffmanInvalidCompressedFile&);
+    }
+}
+
 TEST_CASE("Table") {
     SUBCASE("default constructor") {
         Table table;
@@ -200,5 +533,8 @@ TEST_CASE("Table") {
         CHECK_THROWS_AS(table.at(maxByte), const HuffmanLogicError&);
         table[1].clear();
         CHECK_THROWS_AS(table.at(1), const HuffmanLogicError&);
+        CHECK_THROWS_AS(table.at(byteAlphabetSize), const HuffmanLogicError&);
+        CHECK_THROWS_AS(table[byteAlphabetSize], const HuffmanLogicError&);
+        CHECK_THROWS_AS((Table{{byteAlphabetSize, std::vector<bool> {true}}}), const HuffmanLogicError&);
     }
 }
\ No newline at end of file